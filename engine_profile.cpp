@@ -0,0 +1,417 @@
+#include "engine_profile.h"
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <filesystem>
+#include <algorithm>
+#include <atomic>
+#include <stdexcept>
+#include <cctype>
+#include <sched.h>
+#include <csignal>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/wait.h>
+
+namespace fs = std::filesystem;
+
+// -------------------- Helpers --------------------
+static std::string trim(const std::string& s) {
+    auto start = s.find_first_not_of(" \t\r\n");
+    if (start == std::string::npos) return "";
+    auto end = s.find_last_not_of(" \t\r\n");
+    return s.substr(start, end - start + 1);
+}
+
+static std::string unquote(const std::string& s) {
+    if (s.size() >= 2 && s.front() == '"' && s.back() == '"') return s.substr(1, s.size() - 2);
+    return s;
+}
+
+static bool parse_bool(const std::string& v) {
+    if (v == "1" || v == "on" || v == "true" || v == "yes") return true;
+    if (v == "0" || v == "off" || v == "false" || v == "no") return false;
+    throw std::invalid_argument("not a boolean: " + v);
+}
+
+static int parse_positive(const std::string& v) {
+    size_t used = 0;
+    int n = std::stoi(v, &used);
+    if (used != v.size() || n <= 0) throw std::invalid_argument("not a positive integer: " + v);
+    return n;
+}
+
+// "value   # comment" -> "value"; a '#' or ';' only starts a comment after whitespace.
+static std::string strip_comment(const std::string& s) {
+    for (size_t i = 1; i < s.size(); ++i) {
+        if ((s[i] == '#' || s[i] == ';') && (s[i - 1] == ' ' || s[i - 1] == '\t')) return s.substr(0, i);
+    }
+    return s;
+}
+
+// -------------------- EngineProfile --------------------
+bool EngineProfile::is_setting(const std::string& key) {
+    return key == "path" || key == "hash" || key == "threads" || key == "multipv" ||
+           key == "affinity" || key == "numa" || key.find("option.") == 0;
+}
+
+bool EngineProfile::set(const std::string& key, const std::string& value_) {
+    std::string value = unquote(value_);
+    try {
+        if (key == "path") path = value;
+        else if (key == "hash") hash = parse_positive(value);
+        else if (key == "threads") threads = parse_positive(value);
+        else if (key == "multipv") multipv = parse_positive(value);
+        else if (key == "affinity") {
+            if (value != "none" && value != "auto" && EngineAffinity::parse_cpu_list(value).empty())
+                throw std::invalid_argument("empty cpu list");
+            affinity = value;
+        }
+        else if (key == "numa") numa = parse_bool(value);
+        else if (key.find("option.") == 0) { set_option(key.substr(7), value); return true; }
+        else return false;
+    } catch (const std::exception&) {
+        std::cerr << "[Engine] Invalid value for " << key << ": " << value << "\n";
+        return false;
+    }
+    assigned.insert(key);
+    return true;
+}
+
+void EngineProfile::set_option(const std::string& option, const std::string& value) {
+    for (auto& o : options) {
+        if (o.first == option) { o.second = value; return; }
+    }
+    options.emplace_back(option, value);
+}
+
+std::vector<std::string> EngineProfile::setoption_commands() const {
+    std::vector<std::string> cmds;
+    // Threads before Hash: Stockfish reallocates the hash table when Threads changes.
+    if (threads > 0) cmds.push_back("setoption name Threads value " + std::to_string(threads));
+    if (hash > 0) cmds.push_back("setoption name Hash value " + std::to_string(hash));
+    if (multipv > 0) cmds.push_back("setoption name MultiPV value " + std::to_string(multipv));
+    for (auto& o : options) {
+        cmds.push_back("setoption name " + o.first + (o.second.empty() ? "" : " value " + o.second));
+    }
+    return cmds;
+}
+
+// -------------------- EngineProfiles --------------------
+EngineProfiles::EngineProfiles() {
+    profiles["default"] = EngineProfile();
+}
+
+bool EngineProfiles::load(const std::string& filepath) {
+    std::ifstream file(filepath);
+    if (!file.is_open()) return false;
+
+    EngineProfile* current = &get("default");
+    std::string line;
+    int line_no = 0;
+    while (std::getline(file, line)) {
+        ++line_no;
+        line = trim(strip_comment(line));
+        if (line.empty() || line[0] == '#' || line[0] == ';') continue;
+
+        if (line.front() == '[' && line.back() == ']') {
+            current = &get(trim(line.substr(1, line.size() - 2)));
+            continue;
+        }
+
+        auto eq = line.find('=');
+        if (eq == std::string::npos || !current->set(trim(line.substr(0, eq)), trim(line.substr(eq + 1)))) {
+            std::cerr << "[Engine] " << filepath << ":" << line_no << ": ignoring '" << line << "'\n";
+        }
+    }
+    return true;
+}
+
+bool EngineProfiles::has(const std::string& name) const {
+    return profiles.count(name) > 0;
+}
+
+EngineProfile& EngineProfiles::get(const std::string& name) {
+    auto it = profiles.find(name);
+    if (it != profiles.end()) return it->second;
+    EngineProfile& profile = profiles[name];
+    profile.name = name;
+    return profile;
+}
+
+// Inheritance is resolved at use, so section order in the config file and
+// later edits to "default" do not matter.
+EngineProfile EngineProfiles::resolve(const std::string& name) const {
+    EngineProfile out = profiles.at("default");
+    auto it = profiles.find(name);
+    if (it == profiles.end() || name == "default") return out;
+
+    const EngineProfile& p = it->second;
+    out.name = p.name;
+    for (auto& key : p.assigned) {
+        if (key == "path") out.path = p.path;
+        else if (key == "hash") out.hash = p.hash;
+        else if (key == "threads") out.threads = p.threads;
+        else if (key == "multipv") out.multipv = p.multipv;
+        else if (key == "affinity") out.affinity = p.affinity;
+        else if (key == "numa") out.numa = p.numa;
+    }
+    for (auto& o : p.options) out.set_option(o.first, o.second);
+    return out;
+}
+
+// -------------------- Affinity --------------------
+namespace EngineAffinity {
+
+static std::atomic<int> base_slot{0};
+static std::atomic<int> launched{0};
+
+void set_base_slot(int slot) { base_slot = slot; }
+int next_slot() { return base_slot + launched++; }
+
+std::vector<int> parse_cpu_list(const std::string& list) {
+    std::vector<int> cpus;
+    std::stringstream ss(list);
+    std::string part;
+    while (std::getline(ss, part, ',')) {
+        part = trim(part);
+        if (part.empty()) continue;
+        auto dash = part.find('-');
+        std::string lo = trim(part.substr(0, dash));
+        std::string hi = dash == std::string::npos ? lo : trim(part.substr(dash + 1));
+        size_t used_lo = 0, used_hi = 0;
+        int first = std::stoi(lo, &used_lo);
+        int last = std::stoi(hi, &used_hi);
+        if (used_lo != lo.size() || used_hi != hi.size() || first < 0 || last < first || last >= CPU_SETSIZE)
+            throw std::invalid_argument("bad cpu range: " + part);
+        for (int c = first; c <= last; ++c) cpus.push_back(c);
+    }
+    return cpus;
+}
+
+std::string format_cpu_list(const std::vector<int>& cpus) {
+    std::string out;
+    for (size_t i = 0; i < cpus.size(); ) {
+        size_t j = i;
+        while (j + 1 < cpus.size() && cpus[j + 1] == cpus[j] + 1) ++j;
+        if (!out.empty()) out += ",";
+        out += std::to_string(cpus[i]);
+        if (j > i) out += "-" + std::to_string(cpus[j]);
+        i = j + 1;
+    }
+    return out;
+}
+
+// CPUs this process may run on (respects cgroups / an outer taskset).
+static std::vector<int> allowed_cpus() {
+    std::vector<int> cpus;
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    if (sched_getaffinity(0, sizeof(set), &set) != 0) return cpus;
+    for (int c = 0; c < CPU_SETSIZE; ++c) {
+        if (CPU_ISSET(c, &set)) cpus.push_back(c);
+    }
+    return cpus;
+}
+
+// Split `cpus` into physical cores (hyperthread siblings together), ordered by first CPU.
+static std::vector<std::vector<int>> physical_cores(const std::vector<int>& cpus) {
+    std::map<int,std::vector<int>> cores;
+    for (int c : cpus) {
+        int core = c;
+        std::ifstream f("/sys/devices/system/cpu/cpu" + std::to_string(c) + "/topology/thread_siblings_list");
+        std::string list;
+        if (std::getline(f, list)) {
+            try {
+                auto siblings = parse_cpu_list(list);
+                if (!siblings.empty()) core = *std::min_element(siblings.begin(), siblings.end());
+            } catch (const std::exception&) {}
+        }
+        cores[core].push_back(c);
+    }
+    std::vector<std::vector<int>> out;
+    for (auto& c : cores) out.push_back(c.second);
+    return out;
+}
+
+// One group of physical cores per NUMA node, limited to allowed CPUs. Falls back to a single group.
+static std::vector<std::vector<std::vector<int>>> core_groups(bool numa) {
+    std::vector<int> allowed = allowed_cpus();
+    std::vector<std::vector<int>> groups;
+
+    std::error_code ec;
+    if (numa && fs::is_directory("/sys/devices/system/node", ec)) {
+        std::map<int,std::vector<int>> nodes;
+        for (auto& entry : fs::directory_iterator("/sys/devices/system/node", ec)) {
+            std::string dir = entry.path().filename().string();
+            if (dir.rfind("node", 0) != 0 || dir.size() == 4 ||
+                !std::all_of(dir.begin() + 4, dir.end(), ::isdigit)) continue;
+
+            std::ifstream f(entry.path() / "cpulist");
+            std::string list;
+            std::getline(f, list);
+            std::vector<int> cpus;
+            try {
+                for (int c : parse_cpu_list(list)) {
+                    if (std::binary_search(allowed.begin(), allowed.end(), c)) cpus.push_back(c);
+                }
+            } catch (const std::exception&) {}
+            if (!cpus.empty()) nodes[std::stoi(dir.substr(4))] = cpus;
+        }
+        for (auto& n : nodes) groups.push_back(n.second);
+    }
+
+    if (groups.empty() && !allowed.empty()) groups.push_back(allowed);
+
+    std::vector<std::vector<std::vector<int>>> out;
+    for (auto& g : groups) out.push_back(physical_cores(g));
+    return out;
+}
+
+std::vector<int> resolve(const EngineProfile& profile, int slot) {
+    if (profile.affinity == "none" || profile.affinity.empty()) return {};
+    int threads = profile.threads > 0 ? profile.threads : 1;
+
+    if (profile.affinity != "auto") {
+        std::vector<int> cpus = parse_cpu_list(profile.affinity);
+        if ((int)cpus.size() < threads)
+            std::cerr << "[Engine] '" << profile.name << "': " << threads << " threads on only "
+                      << cpus.size() << " CPUs (" << format_cpu_list(cpus) << ")\n";
+        return cpus;
+    }
+
+    // Each set is `threads` physical cores, with their hyperthread siblings so no
+    // other slot lands on the same core. Full sets from all groups come first,
+    // interleaved so consecutive slots alternate between NUMA nodes; leftover
+    // cores form smaller sets at the end.
+    size_t width = threads;
+    std::vector<std::vector<std::vector<int>>> full, partial; // [group][set] -> cpus
+    for (auto& cores : core_groups(profile.numa)) {
+        std::vector<std::vector<int>> f, p;
+        for (size_t i = 0; i < cores.size(); i += width) {
+            std::vector<int> set;
+            size_t n = std::min(width, cores.size() - i);
+            for (size_t k = i; k < i + n; ++k) set.insert(set.end(), cores[k].begin(), cores[k].end());
+            std::sort(set.begin(), set.end());
+            (n == width ? f : p).push_back(set);
+        }
+        full.push_back(f);
+        partial.push_back(p);
+    }
+
+    std::vector<std::vector<int>> sets;
+    std::vector<size_t> set_cores;
+    for (auto* part : {&full, &partial}) {
+        for (size_t i = 0; ; ++i) {
+            bool any = false;
+            for (size_t g = 0; g < part->size(); ++g) {
+                if (i >= (*part)[g].size()) continue;
+                sets.push_back((*part)[g][i]);
+                set_cores.push_back(part == &full ? width : physical_cores((*part)[g][i]).size());
+                any = true;
+            }
+            if (!any) break;
+        }
+    }
+    if (sets.empty()) {
+        std::cerr << "[Engine] '" << profile.name << "': no CPUs available for affinity=auto, running unpinned\n";
+        return {};
+    }
+
+    size_t idx = slot % sets.size();
+    if ((size_t)slot >= sets.size())
+        std::cerr << "[Engine] '" << profile.name << "': slot " << slot << " exceeds the " << sets.size()
+                  << " available core sets; sharing cores with slot " << idx << "\n";
+    if (set_cores[idx] < width)
+        std::cerr << "[Engine] '" << profile.name << "': slot " << slot << " gets only " << set_cores[idx]
+                  << " physical cores for " << threads << " threads\n";
+    return sets[idx];
+}
+
+} // namespace EngineAffinity
+
+// -------------------- EngineProcess --------------------
+bool EngineProcess::start(const std::string& path, const std::vector<int>& cpus) {
+    cpu_set_t pinned;
+    CPU_ZERO(&pinned);
+    for (int c : cpus) {
+        if (c >= 0 && c < CPU_SETSIZE) CPU_SET(c, &pinned);
+    }
+
+    // to_child/from_child carry UCI traffic; exec_err is close-on-exec and
+    // only receives an errno if execvp() fails.
+    int to_child[2], from_child[2], exec_err[2];
+    if (pipe(to_child) != 0) return false;
+    if (pipe(from_child) != 0) { close(to_child[0]); close(to_child[1]); return false; }
+    if (pipe2(exec_err, O_CLOEXEC) != 0) {
+        close(to_child[0]); close(to_child[1]); close(from_child[0]); close(from_child[1]);
+        return false;
+    }
+
+    pid_t child = fork();
+    if (child < 0) {
+        for (int fd : {to_child[0], to_child[1], from_child[0], from_child[1], exec_err[0], exec_err[1]}) close(fd);
+        return false;
+    }
+
+    if (child == 0) {
+        // Only async-signal-safe calls between fork() and exec.
+        dup2(to_child[0], STDIN_FILENO);
+        dup2(from_child[1], STDOUT_FILENO);
+        close(to_child[0]); close(to_child[1]);
+        close(from_child[0]); close(from_child[1]);
+        close(exec_err[0]);
+
+        if (!cpus.empty() && sched_setaffinity(0, sizeof(pinned), &pinned) != 0) {
+            const char msg[] = "[Engine] Could not pin engine to its CPU set, running unpinned\n";
+            ssize_t ignored = write(STDERR_FILENO, msg, sizeof(msg) - 1);
+            (void)ignored;
+        }
+
+        signal(SIGPIPE, SIG_DFL); // an ignored disposition would survive exec
+        char* argv[] = { const_cast<char*>(path.c_str()), nullptr };
+        execvp(argv[0], argv);
+        int err = errno;
+        ssize_t ignored = write(exec_err[1], &err, sizeof(err));
+        (void)ignored;
+        _exit(127);
+    }
+
+    close(to_child[0]);
+    close(from_child[1]);
+    close(exec_err[1]);
+
+    int err = 0;
+    ssize_t n;
+    do n = read(exec_err[0], &err, sizeof(err)); while (n < 0 && errno == EINTR);
+    close(exec_err[0]);
+    if (n > 0) {
+        close(to_child[1]);
+        close(from_child[0]);
+        waitpid(child, nullptr, 0);
+        std::cerr << "[Engine] exec " << path << ": " << std::strerror(err) << "\n";
+        return false;
+    }
+
+    pid = child;
+    in = fdopen(to_child[1], "w");
+    out = fdopen(from_child[0], "r");
+    if (!in || !out) {
+        if (!in) close(to_child[1]);
+        if (!out) close(from_child[0]);
+        stop();
+        return false;
+    }
+    return true;
+}
+
+void EngineProcess::stop() {
+    if (in) { fclose(in); in = nullptr; }   // EOF on stdin also ends the engine
+    if (out) { fclose(out); out = nullptr; }
+    if (pid > 0) {
+        while (waitpid(pid, nullptr, 0) < 0 && errno == EINTR) {}
+        pid = -1;
+    }
+}
@@ -0,0 +1,62 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <map>
+#include <set>
+#include <utility>
+#include <cstdio>
+#include <sys/types.h>
+
+// Engine settings applied once per session, right after the `uci` handshake.
+struct EngineProfile {
+    std::string name = "default";
+    std::string path = "/usr/games/stockfish";
+    int hash = 0;     // MB, 0 = engine default
+    int threads = 0;  // 0 = engine default
+    int multipv = 0;  // 0 = engine default
+    std::vector<std::pair<std::string,std::string>> options; // extra UCI options, in order
+    std::string affinity = "none"; // none | auto | cpu list ("0-7,16-23")
+    bool numa = false;             // keep the core set on one NUMA node
+    std::set<std::string> assigned; // keys set explicitly; the rest come from "default"
+
+    static bool is_setting(const std::string& key);
+    bool set(const std::string& key, const std::string& value); // false = unknown key or bad value
+    void set_option(const std::string& option, const std::string& value);
+    std::vector<std::string> setoption_commands() const;
+};
+
+class EngineProfiles {
+    std::map<std::string,EngineProfile> profiles;
+
+public:
+    EngineProfiles();
+
+    bool load(const std::string& filepath);
+    bool has(const std::string& name) const;
+    EngineProfile& get(const std::string& name); // creates an empty profile if missing
+    EngineProfile resolve(const std::string& name) const; // "default" overlaid with `name`
+};
+
+namespace EngineAffinity {
+    // Offset for auto core sets when several CHMER processes share a host.
+    void set_base_slot(int slot);
+    int next_slot();
+
+    std::vector<int> parse_cpu_list(const std::string& list);
+    std::string format_cpu_list(const std::vector<int>& cpus);
+    std::vector<int> resolve(const EngineProfile& profile, int slot);
+}
+
+// Engine child process with a two-way pipe: write UCI commands to `in`, read replies from `out`.
+// Writing to an engine that has exited raises SIGPIPE; main() ignores it once at startup
+// so that shows up as a failed write/read instead of killing CHMER.
+struct EngineProcess {
+    pid_t pid = -1;
+    FILE* in = nullptr;
+    FILE* out = nullptr;
+
+    // fork() + execvp(path); the child is pinned to `cpus` (empty = inherit) before exec.
+    bool start(const std::string& path, const std::vector<int>& cpus);
+    void stop();
+    bool running() const { return pid > 0; }
+};
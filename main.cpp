@@ -4,14 +4,21 @@
 #include <iostream>
 #include <thread>
 #include <string>
+#include <csignal>
 
 int main(int argc, char** argv) {
+    // An engine that exits mid-session must not take CHMER down with SIGPIPE
+    std::signal(SIGPIPE, SIG_IGN);
+
     std::string run_file;
     bool gui_flag = false;
     bool debug_flag = false;
     bool update_flag = false;
     bool beta_flag = false;
     bool force_flag = false;
+    std::string stockfish_path; // --stockfish, overrides any profile path
+    std::string engine_config;
+    std::string engine_profile;
 
     // Command-line arguments
     for (int i = 1; i < argc; ++i) {
@@ -28,11 +35,32 @@ int main(int argc, char** argv) {
             beta_flag = true;
         } else if (arg == "--force-update") {
             force_flag = true;
+        } else if (arg == "--stockfish" && i + 1 < argc) {
+            stockfish_path = argv[++i];
+        } else if (arg == "--engine-config" && i + 1 < argc) {
+            engine_config = argv[++i];
+        } else if (arg == "--engine" && i + 1 < argc) {
+            engine_profile = argv[++i];
+        } else if (arg == "--engine-slot" && i + 1 < argc) {
+            std::string value = argv[++i];
+            size_t used = 0;
+            int slot = -1;
+            try { slot = std::stoi(value, &used); } catch (const std::exception&) {}
+            if (used != value.size() || slot < 0) {
+                std::cerr << "--engine-slot expects a non-negative integer, got '" << value << "'\n"
+                          << "See --help for usage.\n";
+                return 1;
+            }
+            EngineAffinity::set_base_slot(slot);
         } else if (arg == "--help") {
             std::cout << "CHMER v4 Options:\n"
                       << "  --run <file>         Run CHMER script\n"
                       << "  --gui                Launch GUI\n"
                       << "  --debug              Enable debug output\n"
+                      << "  --stockfish <path>   Engine binary; overrides path= in profiles\n"
+                      << "  --engine-config <f>  Load engine profiles (Hash, Threads, affinity, ...)\n"
+                      << "  --engine <profile>   Engine profile to use\n"
+                      << "  --engine-slot <n>    Core set index for affinity=auto (one per process)\n"
                       << "  --update             Auto-update to latest release\n"
                       << "  --beta-update        Update to latest pre-release\n"
                       << "  --force-update       Force update even if up-to-date\n"
@@ -47,6 +75,12 @@ int main(int argc, char** argv) {
         updater.check_for_updates(beta_flag, force_flag);
     }
 
+    auto setup_engine = [&](CHMERRunner& runner) {
+        if (!engine_config.empty()) runner.load_engine_config(engine_config);
+        if (!engine_profile.empty()) runner.use_engine_profile(engine_profile);
+        if (!stockfish_path.empty()) runner.override_engine_path(stockfish_path);
+    };
+
     if (gui_flag) {
         // GUI mode: create gui first
         CHMERGui gui;
@@ -56,6 +90,7 @@ int main(int argc, char** argv) {
         // If a script is also provided, run it with GUI reference
         if (!run_file.empty()) {
             CHMERRunner runner("/usr/games/stockfish", &gui, debug_flag);
+            setup_engine(runner);
             runner.run(run_file);
         }
 
@@ -65,6 +100,7 @@ int main(int argc, char** argv) {
         // CLI mode: no GUI object created
         if (!run_file.empty()) {
             CHMERRunner runner("/usr/games/stockfish", nullptr, debug_flag);
+            setup_engine(runner);
             runner.run(run_file);
         }
     }
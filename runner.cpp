@@ -43,11 +43,34 @@ std::string CHMERRunner::extract_bestmove(const std::string& sf_output) {
 
 // -------------------- Constructor / Destructor --------------------
 CHMERRunner::CHMERRunner(const std::string& stockfish_path_, CHMERGui* gui_, bool debug_)
-    : stockfish_path(stockfish_path_), gui(gui_), stockfish(nullptr), debug(debug_),
-      current_script(nullptr), current_idx(0) {}
+    : stockfish_path(stockfish_path_), gui(gui_), debug(debug_),
+      engine_profile("default"), engine_slot(-1), current_script(nullptr), current_idx(0) {
+    engine_profiles.get("default").set("path", stockfish_path);
+}
 
 CHMERRunner::~CHMERRunner() {
-    if (stockfish) pclose(stockfish);
+    stop_stockfish();
+}
+
+// -------------------- Engine Profiles --------------------
+bool CHMERRunner::load_engine_config(const std::string& filepath) {
+    if (!engine_profiles.load(filepath)) {
+        std::cerr << "[Runner] Failed to load engine config: " << filepath << "\n";
+        return false;
+    }
+    if (debug) std::cout << "[Runner] Engine config loaded from " << filepath << "\n";
+    return true;
+}
+
+void CHMERRunner::use_engine_profile(const std::string& name) {
+    if (!engine_profiles.has(name)) std::cerr << "[Runner] Unknown engine profile '" << name << "', using defaults\n";
+    engine_profile = name;
+    stop_stockfish(); // options are applied once per session, so start a new one
+}
+
+void CHMERRunner::override_engine_path(const std::string& path) {
+    engine_path_override = path;
+    stop_stockfish();
 }
 
 // -------------------- Script Loader --------------------
@@ -60,27 +83,69 @@ bool Script::load(const std::string& filepath) {
 }
 
 // -------------------- Stockfish Communication --------------------
-std::string CHMERRunner::send_stockfish(const std::string& cmd) {
-    if (!stockfish) {
-        stockfish = popen(stockfish_path.c_str(), "w+");
-        if (!stockfish) {
-            std::cerr << "Failed to start Stockfish at: " << stockfish_path << std::endl;
-            throw std::runtime_error("Failed to start Stockfish");
-        }
+void CHMERRunner::start_stockfish() {
+    EngineProfile profile = engine_profiles.resolve(engine_profile);
+    if (engine_slot < 0) engine_slot = EngineAffinity::next_slot();
+    std::vector<int> cpus = EngineAffinity::resolve(profile, engine_slot);
+
+    stockfish_path = engine_path_override.empty() ? profile.path : engine_path_override;
+    if (!stockfish.start(stockfish_path, cpus))
+        throw std::runtime_error("Failed to start Stockfish at: " + stockfish_path);
+
+    // UCI handshake, then the profile's options once for the whole session
+    fprintf(stockfish.in, "uci\n");
+    fflush(stockfish.in);
+    if (read_stockfish_until("uciok").find("uciok") == std::string::npos) {
+        stop_stockfish();
+        throw std::runtime_error("Stockfish did not answer uciok");
     }
 
-    fprintf(stockfish, "%s\n", cmd.c_str());
-    fflush(stockfish);
+    for (auto& opt : profile.setoption_commands()) {
+        if (debug) std::cout << "[Runner] " << opt << "\n";
+        fprintf(stockfish.in, "%s\n", opt.c_str());
+    }
+    fprintf(stockfish.in, "isready\n");
+    fflush(stockfish.in);
+    if (read_stockfish_until("readyok").find("readyok") == std::string::npos) {
+        stop_stockfish();
+        throw std::runtime_error("Stockfish did not answer readyok");
+    }
+
+    if (!cpus.empty())
+        std::cerr << "[Engine] '" << profile.name << "' slot " << engine_slot
+                  << " pinned to cpus " << EngineAffinity::format_cpu_list(cpus) << "\n";
+    if (debug) std::cout << "[Runner] Engine '" << profile.name << "' started: " << stockfish_path << "\n";
+}
 
+void CHMERRunner::stop_stockfish() {
+    if (!stockfish.running()) return;
+    fprintf(stockfish.in, "quit\n");
+    fflush(stockfish.in);
+    stockfish.stop();
+}
+
+std::string CHMERRunner::read_stockfish_until(const std::string& token) {
     char buffer[256];
     std::string output;
-    while (fgets(buffer, sizeof(buffer), stockfish)) {
+    while (fgets(buffer, sizeof(buffer), stockfish.out)) {
         output += buffer;
-        if (strstr(buffer, "bestmove")) break;
+        if (strstr(buffer, token.c_str())) break;
     }
     return output;
 }
 
+void CHMERRunner::write_stockfish(const std::string& cmd) {
+    if (!stockfish.running()) start_stockfish();
+
+    fprintf(stockfish.in, "%s\n", cmd.c_str());
+    fflush(stockfish.in);
+}
+
+std::string CHMERRunner::send_stockfish(const std::string& cmd) {
+    write_stockfish(cmd);
+    return read_stockfish_until("bestmove");
+}
+
 // -------------------- Runner --------------------
 void CHMERRunner::run(const std::string& filepath) {
     Script script;
@@ -90,9 +155,15 @@ void CHMERRunner::run(const std::string& filepath) {
     }
 
     current_script = &script;
-    for (current_idx = 0; current_idx < script.lines.size(); ++current_idx) {
-        line_buffer = script.lines[current_idx];
-        execute_line(line_buffer);
+    try {
+        for (current_idx = 0; current_idx < script.lines.size(); ++current_idx) {
+            line_buffer = script.lines[current_idx];
+            execute_line(line_buffer);
+        }
+    } catch (const std::runtime_error& e) {
+        // Engine failures (bad path=, no uciok/readyok) stop the script, not CHMER
+        std::cerr << "[Runner] " << e.what() << " (line " << current_idx + 1 << "), stopping script\n";
+        stop_stockfish();
     }
     current_script = nullptr;
 
@@ -147,8 +218,45 @@ void CHMERRunner::handle_command(const std::string& cmd, const std::vector<std::
         std::string mv = args[0];
         moves.push_back(mv);
         pgn_moves.push_back(mv);
-        std::string sf_cmd = "position startpos moves " + join_moves() + "\n";
-        send_stockfish(sf_cmd);
+        std::string sf_cmd = "position startpos moves " + join_moves();
+        write_stockfish(sf_cmd); // no reply to `position`, so don't wait for bestmove
+    }
+    else if (cmd == "engine-config") {
+        if (args.empty() || args[0].find("file=") != 0) {
+            std::cerr << "[Runner] Usage: engine-config file=\"engines.conf\"\n";
+            return;
+        }
+        std::string filename = args[0].substr(5); // file="engines.conf"
+        if (filename.size() >= 2 && filename.front() == '"') filename = filename.substr(1, filename.size() - 2);
+        load_engine_config(filename);
+    }
+    else if (cmd == "engine") {
+        // engine profile=big hash=1024 threads=8 multipv=1 affinity=auto numa=on path=...
+        std::string name = engine_profile;
+        for (auto& a : args) {
+            if (a.find("profile=") == 0) name = a.substr(8);
+        }
+        EngineProfile& profile = engine_profiles.get(name);
+        for (auto& a : args) {
+            auto eq = a.find('=');
+            if (eq == std::string::npos || a.find("profile=") == 0) continue;
+            if (!EngineProfile::is_setting(a.substr(0, eq)))
+                std::cerr << "[Runner] Unknown engine setting: " << a << "\n";
+            else profile.set(a.substr(0, eq), a.substr(eq + 1)); // reports bad values itself
+        }
+        use_engine_profile(name);
+    }
+    else if (cmd == "engine-option") {
+        // engine-option Skill Level=20 (option names may contain spaces)
+        std::string opt = join_args(args);
+        if (opt.empty() || opt[0] == '=') {
+            std::cerr << "[Runner] Usage: engine-option <name>=<value>\n";
+            return;
+        }
+        auto eq = opt.find('=');
+        engine_profiles.get(engine_profile).set_option(opt.substr(0, eq),
+            eq == std::string::npos ? "" : opt.substr(eq + 1));
+        stop_stockfish();
     }
     else if (cmd == "export") {
         std::string filename = args[0].substr(9); // filename="game.pgn"
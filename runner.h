@@ -3,6 +3,7 @@
 #include <vector>
 #include <map>
 #include <cstdio>
+#include "engine_profile.h"
 
 class CHMERGui; // forward declaration
 
@@ -20,11 +21,20 @@ public:
     void run(const std::string& filepath);
     void execute_line(const std::string& line);
 
+    // Engine profiles: loaded from a config file or set by the script
+    bool load_engine_config(const std::string& filepath);
+    void use_engine_profile(const std::string& name);
+    void override_engine_path(const std::string& path); // wins over any profile's path=
+
 private:
     CHMERGui* gui;
     std::string stockfish_path;
-    FILE* stockfish;
+    EngineProcess stockfish;
     bool debug;
+    EngineProfiles engine_profiles;
+    std::string engine_profile;
+    std::string engine_path_override;
+    int engine_slot;
 
     Script* current_script;
     size_t current_idx;
@@ -40,7 +50,11 @@ private:
     std::string extract_bestmove(const std::string& sf_output);
 
     // Core
-    std::string send_stockfish(const std::string& cmd);
+    void start_stockfish();
+    void stop_stockfish();
+    std::string read_stockfish_until(const std::string& token);
+    void write_stockfish(const std::string& cmd);       // commands with no reply (position, setoption)
+    std::string send_stockfish(const std::string& cmd); // `go` commands, waits for bestmove
     void handle_command(const std::string& cmd, const std::vector<std::string>& args);
     void export_pgn(const std::string& filename); // implement as needed
 };